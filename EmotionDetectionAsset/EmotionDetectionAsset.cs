@@ -819,6 +819,41 @@ namespace AssetPackage
             return DetectEmotionsInLandmarks();
         }
 
+        /// <summary>
+        /// Start recording frames, detection results and timings to a binary log for replay.
+        /// </summary>
+        ///
+        /// <param name="fname">        Filename of the log. </param>
+        /// <param name="downsample">   Keep every n-th pixel of every n-th row (0 records no frames). </param>
+        /// <param name="buffersize">   Size of the ring buffer in bytes (0 for the default). </param>
+        ///
+        /// <returns>
+        /// true if it succeeds, false if it fails.
+        /// </returns>
+        public Boolean StartRecording(String fname, Int32 downsample = 1, Int32 buffersize = 0)
+        {
+            if (DlibWrapper.StartRecording == null)
+            {
+                Log(Severity.Warning, "Wrapper dll does not support recording");
+
+                return false;
+            }
+
+            return DlibWrapper.StartRecording(fname, downsample, buffersize);
+        }
+
+        /// <summary>
+        /// Stop recording. Also called when the process exits.
+        /// </summary>
+        ///
+        /// <returns>
+        /// The number of records dropped because the ring buffer was full.
+        /// </returns>
+        public Int32 StopRecording()
+        {
+            return DlibWrapper.StopRecording != null ? DlibWrapper.StopRecording() : 0;
+        }
+
         /// <summary>
         /// Parse number.
         /// </summary>
@@ -1302,6 +1337,16 @@ namespace AssetPackage
             /// </summary>
             internal static InitDetectorDelagate InitDetector = null;
 
+            /// <summary>
+            /// The start recording (null if not supported by the wrapper).
+            /// </summary>
+            internal static StartRecordingDelegate StartRecording = null;
+
+            /// <summary>
+            /// The stop recording (null if not supported by the wrapper).
+            /// </summary>
+            internal static StopRecordingDelegate StopRecording = null;
+
             /// <summary>
             /// Handle of the wrapper DLL.
             /// </summary>
@@ -1387,6 +1432,20 @@ namespace AssetPackage
 
                     //! 8
                     DetectFacesOld = (DetectFacesOldDelegate)GetDelegate(eda, "DetectFacesOld", typeof(DetectFacesOldDelegate));
+
+                    //! 9
+                    StartRecording = (StartRecordingDelegate)GetOptionalDelegate(eda, "StartRecording", typeof(StartRecordingDelegate));
+
+                    //! 10
+                    StopRecording = (StopRecordingDelegate)GetOptionalDelegate(eda, "StopRecording", typeof(StopRecordingDelegate));
+
+                    // The recording must be stopped before the dll is unloaded, as the wrapper
+                    // cannot join its writer thread while being unloaded.
+                    // 
+                    if (StopRecording != null)
+                    {
+                        AppDomain.CurrentDomain.ProcessExit += (sender, e) => StopRecording();
+                    }
                 }
             }
 
@@ -1426,6 +1485,29 @@ namespace AssetPackage
                 return null;
             }
 
+            /// <summary>
+            /// Gets a delegate for a function older wrapper dlls do not export.
+            /// </summary>
+            ///
+            /// <param name="eda">          The eda. </param>
+            /// <param name="procName">     Name of the proc. </param>
+            /// <param name="delegateType"> Type of the delegate. </param>
+            ///
+            /// <returns>
+            /// The delegate, null if the function is not exported.
+            /// </returns>
+            private static Delegate GetOptionalDelegate(EmotionDetectionAsset eda, string procName, Type delegateType)
+            {
+                if (GetProcAddress(wrapperDllHandle, procName) == IntPtr.Zero)
+                {
+                    eda.Log(Severity.Verbose, "Wrapper function not available: {0}", procName);
+
+                    return null;
+                }
+
+                return GetDelegate(eda, procName, delegateType);
+            }
+
             #region Methods
 
             /// <summary>
@@ -1528,6 +1610,32 @@ namespace AssetPackage
             /// </summary>
             internal delegate void InitDetectorDelagate();
 
+            /// <summary>
+            /// Start recording.
+            /// </summary>
+            ///
+            /// <param name="fname">        Filename of the log. </param>
+            /// <param name="downsample">   The downsample. </param>
+            /// <param name="buffersize">   The size of the ring buffer. </param>
+            ///
+            /// <returns>
+            /// A bool.
+            /// </returns>
+            [return: MarshalAs(UnmanagedType.I1)]
+            internal delegate bool StartRecordingDelegate(
+                [MarshalAs(UnmanagedType.LPStr)]string fname,
+                Int32 downsample,
+                Int32 buffersize);
+
+            /// <summary>
+            /// Stop recording.
+            /// </summary>
+            ///
+            /// <returns>
+            /// The number of records dropped.
+            /// </returns>
+            internal delegate int StopRecordingDelegate();
+
             #endregion Methods
         }
 
@@ -0,0 +1,192 @@
+/*
+* Copyright 2016 Open University of the Netherlands
+*
+* Cite this work as:
+* Bahreini, K., van der Vegt, W. & Westera, W. Multimedia Tools and Applications (2019). https://doi.org/10.1007/s11042-019-7250-z
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* This project has received funding from the European Union’s Horizon
+* 2020 research and innovation programme under grant agreement No 644187.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+	Benchmark of the SetDetectorMask/SetFaceSizeRange configurations of the wrapper.
+
+	Link against the dlibwrapper library (with DLIB_JPEG_SUPPORT for jpg input) and run
+	it on the testinput images:
+
+		detectorbench ..\testinput\franck_02159m.jpg ..\testinput\Kiavash1.jpg
+
+	For every image and configuration it prints a table row with the average
+	DetectFaces time, the speedup over the full detector and how many of the faces
+	found by the full detector are found again (intersection over union of at least 0.5).
+
+	The detector configuration relies on object_detector(scanner, overlap_tester, w),
+	object_detector::get_w and scan_fhog_pyramid::copy_configuration; build against
+	dlib 19.4, the version the dlibwrapper dlls in build\Release were built with.
+*/
+
+#include "dlibwrapper.h"
+
+#include <objbase.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace dlib;
+using namespace std;
+
+/// <summary>
+/// A detector configuration.
+/// </summary>
+struct BenchConfig {
+	const char* name;
+	int mask;
+	int minsize;
+	int maxsize;
+};
+
+/// <summary>
+/// The configurations benchmarked. The first one is the reference.
+/// </summary>
+static const BenchConfig configs[] = {
+	{ "all sub-detectors", 0x1F, 0, 0 },
+	{ "frontal", 0x01, 0, 0 },
+	{ "frontal + rotated", 0x19, 0, 0 },
+	{ "frontal, 120px and up", 0x01, 120, 0 },
+	{ "frontal, 80-240px", 0x01, 80, 240 },
+	{ "frontal, 120-320px", 0x01, 120, 320 },
+};
+
+static const int runs = 10;
+
+/// <summary>
+/// Run DetectFaces on the current image.
+/// </summary>
+///
+/// <returns>
+/// The faces found.
+/// </returns>
+static std::vector<RECT> Detect(void) {
+	RECT** faces = NULL;
+	int facecount = 0;
+
+	DetectFaces(&faces, &facecount);
+
+	std::vector<RECT> results;
+
+	for (int i = 0; i < facecount; i++) {
+		results.push_back(*faces[i]);
+		::CoTaskMemFree(faces[i]);
+	}
+
+	if (faces != NULL) {
+		::CoTaskMemFree(faces);
+	}
+
+	return results;
+}
+
+/// <summary>
+/// Intersection over union of two faces.
+/// </summary>
+static double Overlap(const RECT& a, const RECT& b) {
+	dlib::rectangle ra(a.left, a.top, a.right, a.bottom);
+	dlib::rectangle rb(b.left, b.top, b.right, b.bottom);
+
+	return (double)ra.intersect(rb).area() / (ra.area() + rb.area() - ra.intersect(rb).area());
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		cout << "Usage: detectorbench image [image ...]" << endl;
+
+		return 1;
+	}
+
+	InitDetector();
+
+	cout << "| image | configuration | DetectFaces [ms] | speedup | faces | agreement |" << endl;
+	cout << "|---|---|---:|---:|---:|---:|" << endl;
+
+	for (int arg = 1; arg < argc; arg++) {
+		dlib::array2d<dlib::rgb_pixel> image;
+
+		try {
+			load_image(image, argv[arg]);
+		}
+		catch (exception& e) {
+			cout << argv[arg] << ": " << e.what() << endl;
+			continue;
+		}
+
+		// Hand the image to the wrapper the way the asset does.
+		std::vector<byte> rgb;
+		rgb.reserve(image.size() * 3);
+
+		for (long row = 0; row < image.nr(); row++) {
+			for (long col = 0; col < image.nc(); col++) {
+				rgb.push_back(image[row][col].red);
+				rgb.push_back(image[row][col].green);
+				rgb.push_back(image[row][col].blue);
+			}
+		}
+
+		SetImageToRGB(&rgb[0], image.nc(), image.nr(), false);
+
+		std::vector<RECT> reference;
+		double referencems = 0;
+
+		for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+			SetDetectorMask(configs[c].mask);
+			SetFaceSizeRange(configs[c].minsize, configs[c].maxsize);
+
+			// Warm up.
+			std::vector<RECT> found = Detect();
+
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+			for (int run = 0; run < runs; run++) {
+				Detect();
+			}
+
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / runs;
+
+			if (c == 0) {
+				reference = found;
+				referencems = ms;
+			}
+
+			int matched = 0;
+
+			for (size_t r = 0; r < reference.size(); r++) {
+				for (size_t f = 0; f < found.size(); f++) {
+					if (Overlap(reference[r], found[f]) >= 0.5) {
+						matched++;
+						break;
+					}
+				}
+			}
+
+			cout << "| " << argv[arg] << " (" << image.nc() << "x" << image.nr() << ")"
+				<< " | " << configs[c].name
+				<< " | " << fixed << setprecision(1) << ms
+				<< " | " << setprecision(2) << referencems / ms << "x"
+				<< " | " << found.size()
+				<< " | " << matched << "/" << reference.size() << " |" << endl;
+		}
+	}
+
+	return 0;
+}
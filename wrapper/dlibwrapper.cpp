@@ -53,6 +53,14 @@
 #include <dlib/image_processing.h>
 #include <dlib/image_io.h>
 #include <iostream>
+#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <cmath>
 #include <crtdbg.h>
 
 #include "dlibwrapper.h"
@@ -72,6 +80,20 @@ static void LOG2(char *fmt, char* data, double ms) {
 
 static dlib::frontal_face_detector detector;
 
+// The detector as returned by dlib, detector is configured from it.
+static dlib::frontal_face_detector fullDetector;
+
+static int detectorMask = 0x1F;
+
+static int minFaceSize = 0;
+
+static int maxFaceSize = 0;
+
+// Scale applied to the image before scanning, derived from minFaceSize.
+static double detectorScale = 1.0;
+
+static dlib::array2d<dlib::rgb_pixel> scaled;
+
 static shape_predictor sp;
 
 static dlib::array2d<dlib::rgb_pixel> img;
@@ -87,6 +109,363 @@ struct membuf : std::streambuf {
 	}
 };
 
+// ----------------------------------------------------------------------------------------
+
+/// <summary>
+/// Values that represent the record types of a recording.
+/// </summary>
+enum RecordType : uint32_t {
+	recordFrame = 1,
+	recordFaces = 2,
+	recordLandmarks = 3,
+	recordTiming = 4,
+	recordConfig = 5
+};
+
+/// <summary>
+/// Values that represent the timed stages of a recording.
+/// </summary>
+enum RecordStage : uint32_t {
+	stageLoad = 1,
+	stageDetectFaces = 2,
+	stageDetectLandmarks = 3
+};
+
+/// <summary>
+/// Header preceding every record. Size is the size of the payload following it.
+/// </summary>
+struct RecordHeader {
+	uint32_t type;
+	uint32_t size;
+	uint64_t frame;
+};
+
+/// <summary>
+/// Payload of a recordFrame record, followed by height rows of width rgb pixels.
+/// </summary>
+struct FrameRecord {
+	int32_t width;
+	int32_t height;
+	int32_t downsample;
+	int32_t reserved;
+};
+
+/// <summary>
+/// Payload of a recordConfig record, the detector configuration set by SetDetectorMask and
+/// SetFaceSizeRange.
+/// </summary>
+struct ConfigRecord {
+	int32_t mask;
+	int32_t minsize;
+	int32_t maxsize;
+	int32_t reserved;
+};
+
+/// <summary>
+/// Payload of a recordTiming record.
+/// </summary>
+struct TimingRecord {
+	uint32_t stage;
+	uint32_t reserved;
+	double ms;
+};
+
+typedef std::chrono::high_resolution_clock recordClock;
+
+static const char recordMagic[4] = { 'E', 'D', 'R', 'L' };
+
+static const uint32_t recordVersion = 1;
+
+static const size_t recordBufferSize = 64 * 1024 * 1024;
+
+// Width of the widest downsampled row gathered without allocating.
+static const size_t recordRowSize = 4096;
+
+static std::atomic<bool> recording(false);
+
+static int recordDownsample;
+
+static uint64_t frameno;
+
+static std::vector<rgb_pixel> recordRow;
+
+static std::vector<POINT> recordPoints;
+
+static std::ofstream recordFile;
+
+// The ring buffer. Head and tail only grow, their difference is the number of pending bytes.
+static std::vector<char> ring;
+
+static uint64_t ringHead;
+
+static uint64_t ringTail;
+
+static bool ringStop;
+
+static int ringDropped;
+
+static std::mutex ringLock;
+
+static std::condition_variable ringSignal;
+
+static std::thread ringWriter;
+
+/// <summary>
+/// Reserve space in the ring buffer. The ringLock must be held.
+/// </summary>
+///
+/// <param name="size">	The size. </param>
+///
+/// <returns>
+/// True if it succeeds, false if the record has to be dropped.
+/// </returns>
+static bool RingReserve(size_t size) {
+	if (ring.size() - (ringHead - ringTail) < size) {
+		ringDropped++;
+
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Copy data into reserved space of the ring buffer. The ringLock must be held.
+/// </summary>
+///
+/// <param name="data">	The data. </param>
+/// <param name="size">	The size. </param>
+static void RingCopy(const void* data, size_t size) {
+	if (size == 0) {
+		return;
+	}
+
+	size_t start = ringHead % ring.size();
+	size_t first = ring.size() - start < size ? ring.size() - start : size;
+
+	std::memcpy(&ring[start], data, first);
+	if (size > first) {
+		std::memcpy(&ring[0], (const char*)data + first, size - first);
+	}
+
+	ringHead += size;
+}
+
+/// <summary>
+/// Write the pending bytes [tail, head) of the ring buffer to the recording.
+/// </summary>
+///
+/// <param name="tail">	The tail. </param>
+/// <param name="head">	The head. </param>
+static void RingWrite(uint64_t tail, uint64_t head) {
+	size_t start = tail % ring.size();
+	size_t count = (size_t)(head - tail);
+	size_t first = ring.size() - start < count ? ring.size() - start : count;
+
+	recordFile.write(&ring[start], first);
+	if (count > first) {
+		recordFile.write(&ring[0], count - first);
+	}
+}
+
+/// <summary>
+/// Background thread writing the ring buffer to the recording until stopped and drained.
+/// </summary>
+static void RingWriter(void) {
+	std::unique_lock<std::mutex> lock(ringLock);
+
+	for (;;) {
+		ringSignal.wait(lock, [] { return ringStop || ringHead != ringTail; });
+
+		if (ringHead == ringTail) {
+			break;
+		}
+
+		uint64_t head = ringHead;
+		uint64_t tail = ringTail;
+
+		// The producer only writes outside [tail, head), so the copy runs unlocked.
+		lock.unlock();
+
+		RingWrite(tail, head);
+
+		lock.lock();
+
+		ringTail = head;
+	}
+}
+
+/// <summary>
+/// Append a record to the recording.
+/// </summary>
+///
+/// <param name="type">	The record type. </param>
+/// <param name="data">	The payload. </param>
+/// <param name="size">	The size of the payload. </param>
+static void RecordPush(RecordType type, const void* data, size_t size) {
+	RecordHeader h = { type, (uint32_t)size, frameno };
+
+	{
+		std::lock_guard<std::mutex> lock(ringLock);
+
+		if (!RingReserve(sizeof(h) + size)) {
+			return;
+		}
+
+		RingCopy(&h, sizeof(h));
+		RingCopy(data, size);
+	}
+
+	ringSignal.notify_one();
+}
+
+/// <summary>
+/// Append the time elapsed since start to the recording.
+/// </summary>
+///
+/// <param name="stage">	The stage. </param>
+/// <param name="start">	The start of the stage. </param>
+static void RecordTiming(RecordStage stage, recordClock::time_point start) {
+	if (recording) {
+		TimingRecord t = { stage, 0, std::chrono::duration<double, std::milli>(recordClock::now() - start).count() };
+
+		RecordPush(recordTiming, &t, sizeof(t));
+	}
+}
+
+/// <summary>
+/// Append the detector configuration to the recording.
+/// </summary>
+static void RecordConfig(void) {
+	if (recording) {
+		ConfigRecord c = { detectorMask, minFaceSize, maxFaceSize, 0 };
+
+		RecordPush(recordConfig, &c, sizeof(c));
+	}
+}
+
+/// <summary>
+/// Start a new frame and append the (downsampled) image plus its load time to the recording.
+/// </summary>
+///
+/// <param name="start">	The start of loading the image. </param>
+/// <param name="step"> 	Keep every n-th pixel of every n-th row (0 records no image). </param>
+static void RecordFrame(recordClock::time_point start, int step) {
+	frameno++;
+
+	if (!recording) {
+		return;
+	}
+
+	TimingRecord t = { stageLoad, 0, std::chrono::duration<double, std::milli>(recordClock::now() - start).count() };
+
+	if (step > 0 && img.size() != 0) {
+		FrameRecord f = { (int32_t)((img.nc() + step - 1) / step), (int32_t)((img.nr() + step - 1) / step), step, 0 };
+
+		size_t rowsize = f.width * sizeof(rgb_pixel);
+
+		RecordHeader h = { recordFrame, (uint32_t)(sizeof(f) + rowsize * f.height), frameno };
+
+		// Only frames wider than recordRowSize (after downsampling) grow the row buffer.
+		if (step > 1 && recordRow.size() < (size_t)f.width) {
+			recordRow.resize(f.width);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(ringLock);
+
+			if (RingReserve(sizeof(h) + h.size)) {
+				RingCopy(&h, sizeof(h));
+				RingCopy(&f, sizeof(f));
+
+				for (long row = 0; row < img.nr(); row += step) {
+					if (step == 1) {
+						RingCopy(&img[row][0], rowsize);
+					}
+					else {
+						rgb_pixel* src = &img[row][0];
+						for (long col = 0, i = 0; col < img.nc(); col += step, i++) {
+							recordRow[i] = src[col];
+						}
+						RingCopy(&recordRow[0], rowsize);
+					}
+				}
+			}
+		}
+
+		ringSignal.notify_one();
+	}
+
+	RecordPush(recordTiming, &t, sizeof(t));
+}
+
+/// <summary>
+/// Free results allocated with CoTaskMemAlloc.
+/// </summary>
+///
+/// <param name="results">	[in,out] If non-null, the results. </param>
+/// <param name="count">  	Number of results. </param>
+static void FreeResults(void** results, int count) {
+	if (results != NULL) {
+		for (int i = 0; i < count; i++) {
+			::CoTaskMemFree(results[i]);
+		}
+		::CoTaskMemFree(results);
+	}
+}
+
+/// <summary>
+/// Configure detector from fullDetector, detectorMask and the face size range.
+/// </summary>
+static void ConfigureDetector(void) {
+	detectorScale = 1.0;
+
+	// Pyramid level 0 finds faces of about the window size, every next level 6/5 larger ones.
+	double window = (double)fullDetector.get_scanner().get_detection_window_width();
+
+	// A minimum up to the window size prunes nothing, DetectFaces only filters the results.
+	if (detectorMask == 0x1F && minFaceSize <= window && maxFaceSize == 0) {
+		detector = fullDetector;
+
+		return;
+	}
+
+	// Keep only the filters of the selected sub-detectors.
+	std::vector<frontal_face_detector::feature_vector_type> w;
+
+	for (unsigned long i = 0; i < fullDetector.num_detectors(); i++) {
+		if (detectorMask & (1 << i)) {
+			w.push_back(fullDetector.get_w(i));
+		}
+	}
+
+	frontal_face_detector::image_scanner_type scanner;
+	scanner.copy_configuration(fullDetector.get_scanner());
+
+	// Skip the levels below minFaceSize by downscaling the image instead.
+	if (minFaceSize > window) {
+		detectorScale = window / minFaceSize;
+	}
+
+	// Stop the pyramid at the first level whose faces exceed maxFaceSize.
+	if (maxFaceSize > 0) {
+		double largest = maxFaceSize * detectorScale;
+		unsigned long levels = 1;
+
+		if (largest > window) {
+			levels += (unsigned long)std::ceil(std::log(largest / window) / std::log(6.0 / 5.0));
+		}
+
+		scanner.set_max_pyramid_levels(levels);
+	}
+
+	detector = frontal_face_detector(scanner, fullDetector.get_overlap_tester(), w);
+
+	if (verbose) {
+		_RPT4(_CRT_WARN, "Detector mask: %x, sub-detectors: %d, scale: %0.2f, levels: %d\n", detectorMask, w.size(), detectorScale, scanner.get_max_pyramid_levels());
+	}
+}
+
 /// <summary>
 /// We need a face detector.  We will use this to get bounding boxes for each face in an image.
 /// </summary>
@@ -96,8 +475,62 @@ extern void InitDetector(void) {
 		if (verbose) {
 			cout << "InitDetector: " << endl;
 		}
-		detector = dlib::get_frontal_face_detector();
+		fullDetector = dlib::get_frontal_face_detector();
+
+		ConfigureDetector();
+	}
+}
+
+/// <summary>
+/// Select the HOG sub-detectors.
+/// </summary>
+///
+/// <param name="mask">	The sub-detector mask. </param>
+///
+/// <returns>
+/// True if it succeeds, false if it fails.
+/// </returns>
+extern bool SetDetectorMask(int mask) {
+	if ((mask & 0x1F) == 0) {
+		return false;
+	}
+
+	detectorMask = mask & 0x1F;
+
+	if (fullDetector.num_detectors() != 0) {
+		ConfigureDetector();
+	}
+
+	RecordConfig();
+
+	return true;
+}
+
+/// <summary>
+/// Restrict the face size range.
+/// </summary>
+///
+/// <param name="minsize">	The minimum face size (0 for no minimum). </param>
+/// <param name="maxsize">	The maximum face size (0 for no maximum). </param>
+///
+/// <returns>
+/// True if it succeeds, false if it fails.
+/// </returns>
+extern bool SetFaceSizeRange(int minsize, int maxsize) {
+	if (minsize < 0 || maxsize < 0 || (maxsize != 0 && maxsize < minsize)) {
+		return false;
+	}
+
+	minFaceSize = minsize;
+	maxFaceSize = maxsize;
+
+	if (fullDetector.num_detectors() != 0) {
+		ConfigureDetector();
 	}
+
+	RecordConfig();
+
+	return true;
 }
 
 /// <summary>
@@ -125,6 +558,8 @@ extern void InitDatabase(char* pszString) {
 /// <param name="bytes">		[in,out] If non-null, the bytes. </param>
 /// <param name="size">			The size. </param>
 extern bool SetImageToBmp(byte* bytes, int size) {
+	recordClock::time_point loadStart = recordClock::now();
+
 	if (verbose) {
 		cout << "SetImageToBmp: " << endl;
 
@@ -154,6 +589,8 @@ extern bool SetImageToBmp(byte* bytes, int size) {
 		}
 	}
 
+	RecordFrame(loadStart, recordDownsample);
+
 	return true;
 }
 
@@ -174,6 +611,8 @@ extern bool SetImageToBmp(byte* bytes, int size) {
 /// True if it succeeds, false if it fails.
 /// </returns>
 extern bool SetImageToRGB(byte* bytes, int width, int height, bool flip) {
+	recordClock::time_point loadStart = recordClock::now();
+
 	std::vector<RECT> results;
 
 	// Expect 3 bytes per pixel.
@@ -232,6 +671,8 @@ extern bool SetImageToRGB(byte* bytes, int width, int height, bool flip) {
 		//intarray2bmp("dump.bmp", img, height, width);
 	}
 
+	RecordFrame(loadStart, recordDownsample);
+
 	return true;
 }
 
@@ -252,6 +693,8 @@ extern bool SetImageToRGB(byte* bytes, int width, int height, bool flip) {
 /// True if it succeeds, false if it fails.
 /// </returns>
 extern bool SetImageToRGBA(byte* bytes, int width, int height, bool flip) {
+	recordClock::time_point loadStart = recordClock::now();
+
 	std::vector<RECT> results;
 
 	img.set_size(height, width);
@@ -315,6 +758,8 @@ extern bool SetImageToRGBA(byte* bytes, int width, int height, bool flip) {
 		//intarray2bmp("dump.bmp", img, height, width);
 	}
 
+	RecordFrame(loadStart, recordDownsample);
+
 	return true;
 }
 
@@ -337,11 +782,31 @@ extern void DetectFaces(RECT*** faces, int* facecount) {
 
 		std::vector<dlib::rectangle> dets;
 
+		recordClock::time_point start = recordClock::now();
+
 		speedtest__("detect faces: ")
 		{
-			dets = detector(img);
+			if (detectorScale < 1.0) {
+				scaled.set_size((long)(img.nr() * detectorScale + 0.5), (long)(img.nc() * detectorScale + 0.5));
+				resize_image(img, scaled);
+
+				dets = detector(scaled);
+
+				for (std::vector<int>::size_type i = 0; i != dets.size(); i++) {
+					dets[i] = dlib::rectangle(
+						(long)std::floor(dets[i].left() / detectorScale + 0.5),
+						(long)std::floor(dets[i].top() / detectorScale + 0.5),
+						(long)std::floor((dets[i].right() + 1) / detectorScale + 0.5) - 1,
+						(long)std::floor((dets[i].bottom() + 1) / detectorScale + 0.5) - 1);
+				}
+			}
+			else {
+				dets = detector(img);
+			}
 		}
 
+		RecordTiming(stageDetectFaces, start);
+
 		if (verbose) {
 			_RPT1(_CRT_WARN, "Number of faces detected: %d\n", dets.size());
 			cout << "Number of faces detected: " << dets.size() << endl;
@@ -353,6 +818,10 @@ extern void DetectFaces(RECT*** faces, int* facecount) {
 
 			dlib::rectangle rect = dets[i];
 
+			if ((minFaceSize != 0 && (long)rect.width() < minFaceSize) || (maxFaceSize != 0 && (long)rect.width() > maxFaceSize)) {
+				continue;
+			}
+
 			if (verbose) {
 				_RPT4(_CRT_WARN, "Left: %d, Top: %d, Width: %d, Height: %d\n", rect.left(), rect.top(), rect.width(), rect.height());
 				cout << "Left: " << rect.left() << ", Top: " << rect.top() << ", Width: " << rect.width() << ", Height: " << rect.height() << endl;
@@ -368,6 +837,10 @@ extern void DetectFaces(RECT*** faces, int* facecount) {
 		}
 	}
 
+	if (recording) {
+		RecordPush(recordFaces, results.empty() ? NULL : &results[0], sizeof(RECT) * results.size());
+	}
+
 	_RPT0(_CRT_WARN, "\n");
 
 	// See https://limbioliong.wordpress.com/2011/08/14/returning-an-array-of-strings-from-c-to-c-part-1/
@@ -426,8 +899,25 @@ extern void DetectLandmarks(RECT face, POINT*** landmarks, int* markcount) {
 
 		dlib::rectangle rect(face.left, face.top, face.right, face.bottom);
 
+		recordClock::time_point start = recordClock::now();
+
 		full_object_detection shape = sp(img, rect);
 
+		RecordTiming(stageDetectLandmarks, start);
+
+		if (recording) {
+			// The face rectangle (the size of two POINTs) is followed by the landmarks.
+			recordPoints.resize(2 + shape.num_parts());
+			std::memcpy(&recordPoints[0], &face, sizeof(RECT));
+
+			for (unsigned long i = 0; i < shape.num_parts(); i++) {
+				recordPoints[2 + i].x = shape.part(i).x();
+				recordPoints[2 + i].y = shape.part(i).y();
+			}
+
+			RecordPush(recordLandmarks, &recordPoints[0], sizeof(RECT) + sizeof(POINT) * shape.num_parts());
+		}
+
 		if (verbose) {
 			_RPT1(_CRT_WARN, "number of parts: %d\n", shape.num_parts());
 			cout << "number of parts: " << shape.num_parts() << endl;
@@ -459,3 +949,404 @@ extern void DetectLandmarks(RECT face, POINT*** landmarks, int* markcount) {
 		}
 	}
 }
+
+/// <summary>
+/// Start recording.
+/// </summary>
+///
+/// <param name="fname">		Filename of the log. </param>
+/// <param name="downsample">	Keep every n-th pixel of every n-th row (0 records no frames). </param>
+/// <param name="buffersize">	Size of the ring buffer in bytes (0 for the default). </param>
+///
+/// <returns>
+/// True if it succeeds, false if it fails.
+/// </returns>
+extern bool StartRecording(char* fname, int downsample, int buffersize) {
+	if (recording) {
+		return false;
+	}
+
+	if (verbose) {
+		cout << "StartRecording: '" << fname << "'" << endl;
+	}
+
+	recordFile.clear();
+	recordFile.open(fname, std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!recordFile) {
+		return false;
+	}
+
+	recordFile.write(recordMagic, sizeof(recordMagic));
+	recordFile.write((const char*)&recordVersion, sizeof(recordVersion));
+
+	// Preallocate (and touch) the ring buffer so the hot path never allocates.
+	ring.assign(buffersize > 0 ? (size_t)buffersize : recordBufferSize, 0);
+
+	ringHead = 0;
+	ringTail = 0;
+	ringStop = false;
+	ringDropped = 0;
+	recordDownsample = downsample;
+
+	// Preallocate the gather buffers too.
+	recordRow.resize(recordRowSize);
+
+	// The face rectangle (the size of two POINTs) followed by the landmarks.
+	recordPoints.reserve(2 + sp.num_parts());
+
+	ringWriter = std::thread(RingWriter);
+
+	recording = true;
+
+	RecordConfig();
+
+	return true;
+}
+
+/// <summary>
+/// Stop recording.
+/// </summary>
+///
+/// <returns>
+/// The number of records dropped.
+/// </returns>
+extern int StopRecording(void) {
+	if (!recording) {
+		return 0;
+	}
+
+	recording = false;
+
+	{
+		std::lock_guard<std::mutex> lock(ringLock);
+
+		ringStop = true;
+	}
+
+	ringSignal.notify_one();
+	ringWriter.join();
+
+	recordFile.close();
+
+	std::vector<char>().swap(ring);
+
+	if (verbose) {
+		_RPT1(_CRT_WARN, "Records dropped: %d\n", ringDropped);
+	}
+
+	return ringDropped;
+}
+
+/// <summary>
+/// Intersection over union of two faces.
+/// </summary>
+///
+/// <param name="a">	The first face. </param>
+/// <param name="b">	The second face. </param>
+///
+/// <returns>
+/// The overlap, 0 for disjoint and 1 for identical faces.
+/// </returns>
+static double FaceOverlap(const RECT& a, const RECT& b) {
+	dlib::rectangle ra(a.left, a.top, a.right, a.bottom);
+	dlib::rectangle rb(b.left, b.top, b.right, b.bottom);
+
+	double both = (double)ra.intersect(rb).area();
+	double either = (double)ra.area() + rb.area() - both;
+
+	return either != 0 ? both / either : 1.0;
+}
+
+/// <summary>
+/// Compare replayed faces with recorded ones. Faces replayed on a downsampled frame are scaled
+/// up and only have to overlap their recorded counterpart by half.
+/// </summary>
+///
+/// <param name="recorded">		The recorded faces. </param>
+/// <param name="count">		Number of recorded faces. </param>
+/// <param name="replayed">		The replayed faces. </param>
+/// <param name="facecount">	Number of replayed faces. </param>
+/// <param name="downsample">	The downsample of the frame. </param>
+///
+/// <returns>
+/// True if the faces match.
+/// </returns>
+static bool SameFaces(const RECT* recorded, size_t count, RECT** replayed, int facecount, int downsample) {
+	if (count != (size_t)facecount) {
+		return false;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		RECT r = *replayed[i];
+
+		if (downsample == 1) {
+			if (std::memcmp(&r, &recorded[i], sizeof(RECT)) != 0) {
+				return false;
+			}
+		}
+		else {
+			r.left *= downsample;
+			r.top *= downsample;
+			r.right = (r.right + 1) * downsample - 1;
+			r.bottom = (r.bottom + 1) * downsample - 1;
+
+			if (FaceOverlap(r, recorded[i]) < 0.5) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Compare replayed landmarks with recorded ones. Landmarks replayed on a downsampled frame are
+/// scaled up and may be off by the downsample.
+/// </summary>
+///
+/// <param name="recorded">		The recorded landmarks. </param>
+/// <param name="count">		Number of recorded landmarks. </param>
+/// <param name="replayed">		The replayed landmarks. </param>
+/// <param name="markcount">	Number of replayed landmarks. </param>
+/// <param name="downsample">	The downsample of the frame. </param>
+///
+/// <returns>
+/// True if the landmarks match.
+/// </returns>
+static bool SameLandmarks(const POINT* recorded, size_t count, POINT** replayed, int markcount, int downsample) {
+	if (count != (size_t)markcount) {
+		return false;
+	}
+
+	LONG tolerance = downsample == 1 ? 0 : downsample;
+
+	for (size_t i = 0; i < count; i++) {
+		LONG dx = replayed[i]->x * downsample - recorded[i].x;
+		LONG dy = replayed[i]->y * downsample - recorded[i].y;
+
+		if (dx < -tolerance || dx > tolerance || dy < -tolerance || dy > tolerance) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Replay a recording.
+/// </summary>
+///
+/// <remarks>
+/// Frames recorded with a downsample larger than 1 are replayed at their reduced size and the
+/// recorded face rectangles are scaled down to match before landmarks are detected. Detection
+/// and timing records of frames that were not recorded (a log without frames, or frames dropped
+/// because the ring buffer was full) are skipped, so a log recorded without frames cannot be
+/// replayed. When recording during a replay, frames are recorded as loaded (without further
+/// downsampling), so detection records of the new log match its frames.
+/// </remarks>
+///
+/// <param name="fname">	Filename of the log. </param>
+/// <param name="stats">	[in,out] If non-null, the statistics of the replay. </param>
+///
+/// <returns>
+/// The number of frames replayed, -1 if the log could not be read, is corrupt or holds no frames.
+/// </returns>
+extern int ReplayRecording(char* fname, ReplayStatistics* stats) {
+	ReplayStatistics rs;
+	std::memset(&rs, 0, sizeof(rs));
+
+	std::ifstream in(fname, std::ios::in | std::ios::binary);
+
+	in.seekg(0, std::ios::end);
+	std::streamoff length = in.tellg();
+	in.seekg(0, std::ios::beg);
+
+	char magic[sizeof(recordMagic)];
+	uint32_t version;
+
+	if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, recordMagic, sizeof(magic)) != 0
+		|| !in.read((char*)&version, sizeof(version)) || version != recordVersion) {
+		return -1;
+	}
+
+	// Replay with the recorded detector configuration, restore the current one when done.
+	struct ConfigRestore {
+		int mask;
+		int minsize;
+		int maxsize;
+
+		~ConfigRestore() {
+			SetDetectorMask(mask);
+			SetFaceSizeRange(minsize, maxsize);
+		}
+	} restore = { detectorMask, minFaceSize, maxFaceSize };
+
+	// The frame loaded last and its downsample (0 while no frame is loaded).
+	uint64_t loaded = 0;
+	int downsample = 0;
+
+	RecordHeader h;
+	std::vector<char> payload;
+
+	try {
+		while (in.read((char*)&h, sizeof(h))) {
+			if (h.size > length - in.tellg()) {
+				return -1;
+			}
+
+			payload.resize(h.size);
+			if (h.size != 0 && !in.read(&payload[0], h.size)) {
+				return -1;
+			}
+
+			// Skip records of frames that were not recorded.
+			if (h.type != recordFrame && h.type != recordConfig && (downsample == 0 || h.frame != loaded)) {
+				continue;
+			}
+
+			switch (h.type) {
+			case recordFrame:
+			{
+				recordClock::time_point start = recordClock::now();
+
+				FrameRecord f;
+				if (h.size < sizeof(f)) {
+					return -1;
+				}
+				std::memcpy(&f, &payload[0], sizeof(f));
+
+				size_t rowsize = f.width * sizeof(rgb_pixel);
+				if (f.width <= 0 || f.height <= 0 || f.downsample <= 0 || h.size != sizeof(f) + rowsize * f.height) {
+					return -1;
+				}
+
+				img.set_size(f.height, f.width);
+
+				for (long row = 0; row < f.height; row++) {
+					std::memcpy(&img[row][0], &payload[sizeof(f) + row * rowsize], rowsize);
+				}
+
+				RecordFrame(start, 1);
+
+				rs.replayedLoadMs += std::chrono::duration<double, std::milli>(recordClock::now() - start).count();
+
+				loaded = h.frame;
+				downsample = f.downsample;
+
+				rs.frames++;
+			}
+			break;
+
+			case recordFaces:
+			{
+				if (h.size % sizeof(RECT) != 0) {
+					return -1;
+				}
+
+				RECT** faces = NULL;
+				int facecount = 0;
+
+				recordClock::time_point start = recordClock::now();
+
+				DetectFaces(&faces, &facecount);
+
+				rs.replayedFacesMs += std::chrono::duration<double, std::milli>(recordClock::now() - start).count();
+
+				rs.faceCalls++;
+				if (!SameFaces((const RECT*)(payload.empty() ? NULL : &payload[0]), h.size / sizeof(RECT), faces, facecount, downsample)) {
+					rs.faceMismatches++;
+				}
+
+				FreeResults((void**)faces, facecount);
+			}
+			break;
+
+			case recordLandmarks:
+			{
+				RECT face;
+				if (h.size < sizeof(face) || (h.size - sizeof(face)) % sizeof(POINT) != 0) {
+					return -1;
+				}
+				std::memcpy(&face, &payload[0], sizeof(face));
+
+				// The face was recorded in the coordinates of the original frame.
+				if (downsample > 1) {
+					face.left = (LONG)std::floor((double)face.left / downsample);
+					face.top = (LONG)std::floor((double)face.top / downsample);
+					face.right = (LONG)std::floor((double)face.right / downsample);
+					face.bottom = (LONG)std::floor((double)face.bottom / downsample);
+				}
+
+				POINT** landmarks = NULL;
+				int markcount = 0;
+
+				recordClock::time_point start = recordClock::now();
+
+				DetectLandmarks(face, &landmarks, &markcount);
+
+				rs.replayedLandmarksMs += std::chrono::duration<double, std::milli>(recordClock::now() - start).count();
+
+				rs.landmarkCalls++;
+				if (!SameLandmarks((const POINT*)&payload[sizeof(face)], (h.size - sizeof(face)) / sizeof(POINT), landmarks, markcount, downsample)) {
+					rs.landmarkMismatches++;
+				}
+
+				FreeResults((void**)landmarks, markcount);
+			}
+			break;
+
+			case recordConfig:
+			{
+				ConfigRecord c;
+				if (h.size != sizeof(c)) {
+					return -1;
+				}
+				std::memcpy(&c, &payload[0], sizeof(c));
+
+				if (!SetDetectorMask(c.mask) || !SetFaceSizeRange(c.minsize, c.maxsize)) {
+					return -1;
+				}
+			}
+			break;
+
+			case recordTiming:
+			{
+				TimingRecord t;
+				if (h.size != sizeof(t)) {
+					return -1;
+				}
+				std::memcpy(&t, &payload[0], sizeof(t));
+
+				switch (t.stage) {
+				case stageLoad:
+					rs.recordedLoadMs += t.ms;
+					break;
+				case stageDetectFaces:
+					rs.recordedFacesMs += t.ms;
+					break;
+				case stageDetectLandmarks:
+					rs.recordedLandmarksMs += t.ms;
+					break;
+				}
+			}
+			break;
+
+			default:
+				break;
+			}
+		}
+	}
+	catch (exception e) {
+		return -1;
+	}
+
+	if (verbose) {
+		_RPT4(_CRT_WARN, "Replayed frames: %d, face mismatches: %d/%d, landmark mismatches: %d\n", rs.frames, rs.faceMismatches, rs.faceCalls, rs.landmarkMismatches);
+	}
+
+	if (stats != NULL) {
+		*stats = rs;
+	}
+
+	return rs.frames != 0 ? rs.frames : -1;
+}
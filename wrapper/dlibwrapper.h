@@ -38,6 +38,37 @@
 /// </summary>
 extern "C" __declspec(dllexport) void InitDetector(void);
 
+/// <summary>
+/// Select the HOG sub-detectors used by DetectFaces.
+/// 
+/// Bit 0 enables the frontal detector, bit 1 the left looking, bit 2 the right looking,
+/// bit 3 the frontal but rotated left and bit 4 the frontal but rotated right detector.
+/// Filters of disabled sub-detectors are not convolved at all. The default is 0x1F (all).
+/// </summary>
+///
+/// <param name="mask">	The sub-detector mask. </param>
+///
+/// <returns>
+/// True if it succeeds, false if the mask selects no sub-detector.
+/// </returns>
+extern "C" __declspec(dllexport) bool SetDetectorMask(int mask);
+
+/// <summary>
+/// Restrict the size (in pixels) of the faces returned by DetectFaces.
+/// 
+/// Pyramid levels that can only produce faces outside this range are not scanned.
+/// A minimum above the 80 pixel detection window downscales the image before scanning.
+/// A minimum up to 80 pixels prunes nothing and only filters the results.
+/// </summary>
+///
+/// <param name="minsize">	The minimum face size (0 for no minimum). </param>
+/// <param name="maxsize">	The maximum face size (0 for no maximum). </param>
+///
+/// <returns>
+/// True if it succeeds, false if the range is invalid.
+/// </returns>
+extern "C" __declspec(dllexport) bool SetFaceSizeRange(int minsize, int maxsize);
+
 /// <summary>
 /// Init database.
 /// </summary>
@@ -114,6 +145,76 @@ extern "C"	__declspec(dllexport) void DetectFacesOld(byte* img, int size, RECT**
 /// <param name="markcount">	[in,out] If non-null, the markcount. </param>
 extern "C"	__declspec(dllexport) void DetectLandmarks(RECT face, POINT*** landmarks, int* markcount);
 
+/// <summary>
+/// Start recording frames, detection results and per-stage timings to a binary log.
+/// 
+/// Records are copied into a preallocated ring buffer and written to disk by a background
+/// thread, so the detection calls never wait on file I/O. When the ring buffer is full,
+/// records are dropped (and counted) instead of stalling the caller.
+/// </summary>
+///
+/// <param name="fname">		Filename of the log. </param>
+/// <param name="downsample">	Keep every n-th pixel of every n-th row (1 records full frames, 0 records no frames and cannot be replayed). </param>
+/// <param name="buffersize">	Size of the ring buffer in bytes (0 for the default of 64MB). </param>
+///
+/// <returns>
+/// True if it succeeds, false if it fails.
+/// </returns>
+extern "C"	__declspec(dllexport) bool StartRecording(char* fname, int downsample, int buffersize);
+
+/// <summary>
+/// Stop recording, flush the ring buffer and close the log.
+/// 
+/// Must be called before the dll is unloaded; it joins the writer thread and so cannot be
+/// called from DllMain or static destructors.
+/// </summary>
+///
+/// <returns>
+/// The number of records dropped because the ring buffer was full.
+/// </returns>
+extern "C"	__declspec(dllexport) int StopRecording(void);
+
+/// <summary>
+/// Statistics of a replay. Timings are totals in milliseconds per stage, as recorded and as
+/// replayed. Mismatches count the DetectFaces/DetectLandmarks calls whose replayed results
+/// differ from the recorded ones.
+/// </summary>
+struct ReplayStatistics {
+	int frames;
+	int faceCalls;
+	int faceMismatches;
+	int landmarkCalls;
+	int landmarkMismatches;
+	double recordedLoadMs;
+	double recordedFacesMs;
+	double recordedLandmarksMs;
+	double replayedLoadMs;
+	double replayedFacesMs;
+	double replayedLandmarksMs;
+};
+
+/// <summary>
+/// Replay a log recorded by StartRecording through the face and landmark detection.
+/// 
+/// Every recorded frame is loaded and every recorded DetectFaces/DetectLandmarks call
+/// is repeated in the original order and its results are compared with the recorded ones.
+/// Downsampled frames are replayed at their reduced size, with the recorded face rectangles
+/// scaled to match; their results then only have to match approximately. Records of frames
+/// that were not recorded are skipped. The detector configuration (SetDetectorMask and
+/// SetFaceSizeRange) is recorded at StartRecording and on every change, replayed with the
+/// session and restored afterwards. If a recording is active,
+/// the replayed session (including fresh timings) is recorded too, with frames stored
+/// as replayed.
+/// </summary>
+///
+/// <param name="fname">	Filename of the log. </param>
+/// <param name="stats">	[in,out] If non-null, the statistics of the replay. </param>
+///
+/// <returns>
+/// The number of frames replayed, -1 if the log could not be read, is corrupt or holds no frames.
+/// </returns>
+extern "C"	__declspec(dllexport) int ReplayRecording(char* fname, ReplayStatistics* stats);
+
 // TEST START
 
 // 
@@ -0,0 +1,226 @@
+/*
+* Copyright 2016 Open University of the Netherlands
+*
+* Cite this work as:
+* Bahreini, K., van der Vegt, W. & Westera, W. Multimedia Tools and Applications (2019). https://doi.org/10.1007/s11042-019-7250-z
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* This project has received funding from the European Union’s Horizon
+* 2020 research and innovation programme under grant agreement No 644187.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+	Record and replay round trip of the StartRecording/StopRecording/ReplayRecording
+	exports of the wrapper.
+
+	Link against the dlibwrapper library (with DLIB_JPEG_SUPPORT for jpg input) and run
+	it with the landmark database and the testinput images:
+
+		recordertest shape_predictor_68_face_landmarks.dat ..\testinput\franck_02159m.jpg
+			..\testinput\franck_02159m_small.jpg ..\testinput\Kiavash1.jpg
+
+	The images are processed the way the asset does (DetectFaces, then DetectLandmarks
+	for every face) a number of times while recording into a ring buffer of about two
+	frames, so the ring wraps around. The log is then replayed and the frame count and
+	the replayed faces and landmarks are checked against the recording. Full frames must
+	replay exactly; for downsampled frames, where small faces may be lost, the mismatches
+	are only reported. A session recorded with only the frontal sub-detector must replay
+	exactly while the full detector is configured. Finally a ring buffer smaller than a
+	frame must drop every frame and give a log that cannot be replayed.
+
+	Returns 0 if all checks pass.
+*/
+
+#include "dlibwrapper.h"
+
+#include <objbase.h>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace dlib;
+using namespace std;
+
+static const char* logname = "recordertest.edrl";
+
+static const int passes = 3;
+
+static int failures = 0;
+
+/// <summary>
+/// Report a check.
+/// </summary>
+///
+/// <param name="ok">  	True if the check passed. </param>
+/// <param name="what">	What was checked. </param>
+static void Check(bool ok, const char* what) {
+	cout << (ok ? "PASS " : "FAIL ") << what << endl;
+
+	if (!ok) {
+		failures++;
+	}
+}
+
+/// <summary>
+/// Process the current image the way the asset does.
+/// </summary>
+static void Process(void) {
+	RECT** faces = NULL;
+	int facecount = 0;
+
+	DetectFaces(&faces, &facecount);
+
+	for (int i = 0; i < facecount; i++) {
+		POINT** landmarks = NULL;
+		int markcount = 0;
+
+		DetectLandmarks(*faces[i], &landmarks, &markcount);
+
+		for (int j = 0; j < markcount; j++) {
+			::CoTaskMemFree(landmarks[j]);
+		}
+		if (landmarks != NULL) {
+			::CoTaskMemFree(landmarks);
+		}
+
+		::CoTaskMemFree(faces[i]);
+	}
+
+	if (faces != NULL) {
+		::CoTaskMemFree(faces);
+	}
+}
+
+/// <summary>
+/// Record all images passes times.
+/// </summary>
+///
+/// <param name="images">		The images as RGB bytes. </param>
+/// <param name="sizes">		The width and height of the images. </param>
+/// <param name="downsample">	The downsample. </param>
+/// <param name="buffersize">	The size of the ring buffer. </param>
+///
+/// <returns>
+/// The number of records dropped, -1 if recording could not be started.
+/// </returns>
+static int Record(std::vector<std::vector<byte> >& images, std::vector<std::pair<int, int> >& sizes, int downsample, int buffersize) {
+	if (!StartRecording((char*)logname, downsample, buffersize)) {
+		return -1;
+	}
+
+	for (int pass = 0; pass < passes; pass++) {
+		for (size_t i = 0; i < images.size(); i++) {
+			SetImageToRGB(&images[i][0], sizes[i].first, sizes[i].second, false);
+
+			Process();
+		}
+	}
+
+	return StopRecording();
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		cout << "Usage: recordertest database image [image ...]" << endl;
+
+		return 1;
+	}
+
+	InitDetector();
+	InitDatabase(argv[1]);
+
+	std::vector<std::vector<byte> > images;
+	std::vector<std::pair<int, int> > sizes;
+
+	size_t largest = 0;
+
+	for (int arg = 2; arg < argc; arg++) {
+		dlib::array2d<dlib::rgb_pixel> image;
+
+		try {
+			load_image(image, argv[arg]);
+		}
+		catch (exception& e) {
+			cout << argv[arg] << ": " << e.what() << endl;
+			return 1;
+		}
+
+		std::vector<byte> rgb;
+		rgb.reserve(image.size() * 3);
+
+		for (long row = 0; row < image.nr(); row++) {
+			for (long col = 0; col < image.nc(); col++) {
+				rgb.push_back(image[row][col].red);
+				rgb.push_back(image[row][col].green);
+				rgb.push_back(image[row][col].blue);
+			}
+		}
+
+		largest = rgb.size() > largest ? rgb.size() : largest;
+
+		images.push_back(rgb);
+		sizes.push_back(std::make_pair((int)image.nc(), (int)image.nr()));
+	}
+
+	int frames = (int)images.size() * passes;
+
+	// Room for about two of the largest frames, so the ring wraps around during recording.
+	int buffersize = (int)(2 * largest + 64 * 1024);
+
+	for (int downsample = 1; downsample <= 2; downsample++) {
+		cout << "downsample " << downsample << endl;
+
+		int dropped = Record(images, sizes, downsample, buffersize);
+
+		Check(dropped == 0, "no records dropped");
+
+		ReplayStatistics stats;
+
+		Check(ReplayRecording((char*)logname, &stats) == frames, "all frames replayed");
+		Check(stats.faceCalls == frames, "all DetectFaces calls replayed");
+		if (downsample == 1) {
+			Check(stats.faceMismatches == 0, "replayed faces match");
+			Check(stats.landmarkMismatches == 0, "replayed landmarks match");
+		}
+		else {
+			cout << "  mismatches: " << stats.faceMismatches << "/" << stats.faceCalls << " faces, "
+				<< stats.landmarkMismatches << "/" << stats.landmarkCalls << " landmarks" << endl;
+		}
+
+		cout << "  load [ms]: " << stats.recordedLoadMs << " recorded, " << stats.replayedLoadMs << " replayed" << endl;
+		cout << "  faces [ms]: " << stats.recordedFacesMs << " recorded, " << stats.replayedFacesMs << " replayed" << endl;
+		cout << "  landmarks [ms]: " << stats.recordedLandmarksMs << " recorded, " << stats.replayedLandmarksMs << " replayed" << endl;
+	}
+
+	// The detector configuration is part of the recording.
+	cout << "frontal sub-detector only" << endl;
+
+	SetDetectorMask(0x01);
+	Check(Record(images, sizes, 1, buffersize) == 0, "no records dropped");
+	SetDetectorMask(0x1F);
+
+	ReplayStatistics stats;
+
+	Check(ReplayRecording((char*)logname, &stats) == frames, "all frames replayed");
+	Check(stats.faceMismatches == 0 && stats.landmarkMismatches == 0, "replayed with the recorded configuration");
+
+	// A ring buffer smaller than any frame drops every frame.
+	cout << "ring buffer smaller than a frame" << endl;
+
+	Check(Record(images, sizes, 1, 16 * 1024) >= frames, "all frames dropped");
+	Check(ReplayRecording((char*)logname, NULL) == -1, "log without frames not replayed");
+
+	std::remove(logname);
+
+	return failures != 0 ? 1 : 0;
+}